@@ -7,6 +7,7 @@
 #include "idisa_avx_builder.h"
 #include "idisa_target.h"
 #include <toolchain/toolchain.h>
+#include <algorithm>
 
 using namespace llvm;
 
@@ -256,6 +257,191 @@ Value * IDISA_AVX2_Builder::hsimd_signmask(unsigned fw, Value * a) {
     return IDISA_AVX_Builder::hsimd_signmask(fw, a);
 }
 
+// Sorts ranges and merges any that overlap or touch, so equal classes compare equal.
+static std::vector<std::pair<unsigned, unsigned>> normalizeByteRanges(std::vector<std::pair<unsigned, unsigned>> ranges) {
+    std::sort(ranges.begin(), ranges.end());
+    std::vector<std::pair<unsigned, unsigned>> merged;
+    for (const auto & range : ranges) {
+        if (!merged.empty() && (range.first <= merged.back().second + 1)) {
+            merged.back().second = std::max(merged.back().second, range.second);
+        } else {
+            merged.push_back(range);
+        }
+    }
+    return merged;
+}
+
+static void checkByteRanges(const std::vector<std::pair<unsigned, unsigned>> & ranges) {
+    for (const auto & range : ranges) {
+        if ((range.first > range.second) || (range.second > 0xFF)) {
+            llvm::report_fatal_error("byte ranges require lo <= hi <= 0xFF");
+        }
+    }
+}
+
+Value * IDISA_AVX2_Builder::byteRangesMatch(Value * a, const std::vector<std::pair<unsigned, unsigned>> & ranges, RangeTests * tests) {
+    const unsigned field_count = mBitBlockWidth / 8;
+    Value * bytes = fwCast(8, a);
+    Value * match = Constant::getNullValue(VectorType::get(getInt1Ty(), field_count));
+    for (const auto & range : ranges) {
+        Value * test = nullptr;
+        if (tests) {
+            const auto f = tests->find(range);
+            if (f != tests->end()) {
+                test = f->second;
+            }
+        }
+        if (test == nullptr) {
+            Value * lo = CreateVectorSplat(field_count, getInt8(range.first));
+            if (range.first == range.second) {
+                test = CreateICmpEQ(bytes, lo);
+            } else {
+                // Unsigned range test with one compare: (b - lo) <= (hi - lo)
+                Value * span = CreateVectorSplat(field_count, getInt8(range.second - range.first));
+                test = CreateICmpULE(CreateSub(bytes, lo), span);
+            }
+            if (tests) {
+                tests->emplace(range, test);
+            }
+        }
+        match = CreateOr(match, test);
+    }
+    return match;
+}
+
+Value * IDISA_AVX2_Builder::byteMatchSignmask(Value * match) {
+    if (mBitBlockWidth == 256) {
+        Type * bitBlock_i8type = VectorType::get(getInt8Ty(), mBitBlockWidth/8);
+        return hsimd_signmask(8, CreateSExt(match, bitBlock_i8type));
+    }
+    // Other widths would fall through to the unguarded SSE signmask logic. Bitcasting the
+    // <N x i1> compare result lets llvm pick the movemask sequence; with AVX512BW it
+    // becomes vpcmpub into a k-mask and kmovq.
+    return CreateBitCast(match, getIntNTy(mBitBlockWidth / 8));
+}
+
+std::pair<Value *, Value *> IDISA_AVX2_Builder::byteNibbleLookupBase(Value * a) {
+    // The class independent half of the nibble lookup: the low nibbles of a, and
+    // hiTable[h] = 1 << h for h < 8. Bytes >= 0x80 have h >= 8 and hit a zero entry.
+    const unsigned field_count = mBitBlockWidth / 8;
+    Constant * hiArr[field_count];
+    for (unsigned i = 0; i < field_count; i++) {
+        // vpshufb looks up within each 128-bit lane, so the tables repeat per lane.
+        const unsigned n = i & 0xF;
+        hiArr[i] = getInt8(n < 8 ? 1 << n : 0);
+    }
+    Value * pshufbfunc = Intrinsic::getDeclaration(getModule(), Intrinsic::x86_avx2_pshuf_b);
+    Value * nibbleMask = CreateVectorSplat(field_count, getInt8(0x0F));
+    Value * loNibbles = CreateAnd(fwCast(8, a), nibbleMask);
+    Value * hiNibbles = CreateAnd(fwCast(8, simd_srli(16, a, 4)), nibbleMask);
+    Value * hiBits = CreateCall(pshufbfunc, {ConstantVector::get({hiArr, field_count}), hiNibbles});
+    return std::pair<Value *, Value *>{loNibbles, hiBits};
+}
+
+Value * IDISA_AVX2_Builder::byteNibbleLookupMatch(const std::pair<Value *, Value *> & nibbleBase, const std::vector<std::pair<unsigned, unsigned>> & ranges) {
+    // ASCII only. loTable[lo] has bit h set when byte (h << 4 | lo) is in the class.
+    unsigned loTable[16] = {0};
+    for (const auto & range : ranges) {
+        for (unsigned c = range.first; c <= range.second; c++) {
+            loTable[c & 0xF] |= 1 << (c >> 4);
+        }
+    }
+    const unsigned field_count = mBitBlockWidth / 8;
+    Constant * loArr[field_count];
+    for (unsigned i = 0; i < field_count; i++) {
+        loArr[i] = getInt8(loTable[i & 0xF]);
+    }
+    Value * pshufbfunc = Intrinsic::getDeclaration(getModule(), Intrinsic::x86_avx2_pshuf_b);
+    Value * loBits = CreateCall(pshufbfunc, {ConstantVector::get({loArr, field_count}), nibbleBase.first});
+    Value * bits = CreateAnd(loBits, nibbleBase.second);
+    return CreateICmpNE(bits, Constant::getNullValue(bits->getType()));
+}
+
+bool IDISA_AVX2_Builder::useNibbleLookup(const std::vector<std::pair<unsigned, unsigned>> & ranges) const {
+    if (mBitBlockWidth != 256) {
+        return false;
+    }
+    unsigned maxByte = 0;
+    for (const auto & range : ranges) {
+        maxByte = std::max(maxByte, range.second);
+    }
+    // Past a few ranges the table lookups are cheaper than a compare per range.
+    return (ranges.size() > 3) && (maxByte < 0x80);
+}
+
+Value * IDISA_AVX2_Builder::simd_byte_ranges_signmask(Value * a, const std::vector<std::pair<unsigned, unsigned>> & ranges) {
+    checkByteRanges(ranges);
+    const auto merged = normalizeByteRanges(ranges);
+    Value * match = nullptr;
+    if (useNibbleLookup(merged)) {
+        match = byteNibbleLookupMatch(byteNibbleLookupBase(a), merged);
+    } else {
+        match = byteRangesMatch(a, merged);
+    }
+    return byteMatchSignmask(match);
+}
+
+Value * IDISA_AVX2_Builder::bitblock_byte_ranges(const std::vector<Value *> & byteBlocks, const std::vector<std::pair<unsigned, unsigned>> & ranges) {
+    if (byteBlocks.size() != 8) {
+        llvm::report_fatal_error("bitblock_byte_ranges requires 8 byte blocks");
+    }
+    // Byte block i supplies positions [i * fw, (i + 1) * fw) of the class bitblock.
+    const unsigned fw = mBitBlockWidth / 8;
+    Value * result = allZeroes();
+    for (unsigned i = 0; i < 8; i++) {
+        Value * mask = simd_byte_ranges_signmask(byteBlocks[i], ranges);
+        result = mvmd_insert(fw, result, CreateZExtOrTrunc(mask, getIntNTy(fw)), i);
+    }
+    return bitCast(result);
+}
+
+std::vector<Value *> IDISA_AVX2_Builder::bitblock_byte_ranges(const std::vector<Value *> & byteBlocks, const std::vector<std::vector<std::pair<unsigned, unsigned>>> & classes) {
+    if (byteBlocks.size() != 8) {
+        llvm::report_fatal_error("bitblock_byte_ranges requires 8 byte blocks");
+    }
+    for (const auto & ranges : classes) {
+        checkByteRanges(ranges);
+    }
+    // Classes repeated across patterns, up to range order and splitting, share a single result.
+    std::map<std::vector<std::pair<unsigned, unsigned>>, unsigned> distinct;
+    std::vector<unsigned> classIndex(classes.size());
+    for (unsigned j = 0; j < classes.size(); j++) {
+        classIndex[j] = distinct.emplace(normalizeByteRanges(classes[j]), distinct.size()).first->second;
+    }
+    bool anyNibbleLookup = false;
+    for (const auto & entry : distinct) {
+        anyNibbleLookup |= useNibbleLookup(entry.first);
+    }
+    const unsigned fw = mBitBlockWidth / 8;
+    std::vector<Value *> results(distinct.size(), allZeroes());
+    for (unsigned i = 0; i < 8; i++) {
+        // Within a byte block the nibble split and hiTable lookup are computed once for
+        // all table classes, which then cost one vpshufb each. The remaining classes share
+        // their range compares.
+        std::pair<Value *, Value *> nibbleBase{nullptr, nullptr};
+        if (anyNibbleLookup) {
+            nibbleBase = byteNibbleLookupBase(byteBlocks[i]);
+        }
+        RangeTests tests;
+        for (const auto & entry : distinct) {
+            Value * match = nullptr;
+            if (useNibbleLookup(entry.first)) {
+                match = byteNibbleLookupMatch(nibbleBase, entry.first);
+            } else {
+                match = byteRangesMatch(byteBlocks[i], entry.first, &tests);
+            }
+            Value * mask = byteMatchSignmask(match);
+            Value *& result = results[entry.second];
+            result = mvmd_insert(fw, result, CreateZExtOrTrunc(mask, getIntNTy(fw)), i);
+        }
+    }
+    std::vector<Value *> classBlocks(classes.size());
+    for (unsigned j = 0; j < classes.size(); j++) {
+        classBlocks[j] = bitCast(results[classIndex[j]]);
+    }
+    return classBlocks;
+}
+
 
 std::string IDISA_AVX512F_Builder::getBuilderUniqueName() {
     return mBitBlockWidth != 512 ? "AVX512F_" + std::to_string(mBitBlockWidth) : "AVX512F";
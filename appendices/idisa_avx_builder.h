@@ -8,9 +8,16 @@
 
 #include <IR_Gen/idisa_sse_builder.h>
 #include <llvm/Support/raw_ostream.h>
+#include <llvm/ADT/StringMap.h>
+#include <map>
+#include <utility>
+#include <vector>
 
 namespace IDISA {
 
+//Host CPU features, queried once per process. Defined in idisa_target.cpp.
+const llvm::StringMap<bool> & getHostCPUFeatureMap();
+
 class IDISA_AVX_Builder : public IDISA_SSE2_Builder {
 public:
 
@@ -49,7 +56,28 @@ public:
     std::pair<llvm::Value *, llvm::Value *> bitblock_indexed_advance(llvm::Value * a, llvm::Value * index_strm, llvm::Value * shiftin, unsigned shift) override;
     llvm::Value * hsimd_signmask(unsigned fw, llvm::Value * a) override;
 
+    //Byte-space character classes: match bytes against inclusive [lo, hi] ranges
+    //without transposing to basis bits. Returns one mask bit per byte of a.
+    llvm::Value * simd_byte_ranges_signmask(llvm::Value * a, const std::vector<std::pair<unsigned, unsigned>> & ranges);
+    //Builds a full class bitblock from the BitBlockWidth bytes held in 8 consecutive byte blocks.
+    llvm::Value * bitblock_byte_ranges(const std::vector<llvm::Value *> & byteBlocks, const std::vector<std::pair<unsigned, unsigned>> & ranges);
+    //Batch form for many patterns over the same input: one bitblock per class.
+    //Equal classes are computed once, and per byte block the nibble lookup setup and
+    //each distinct range compare are shared. The OR of ranges is still built per class,
+    //so classes that merely overlap share only their common ranges.
+    std::vector<llvm::Value *> bitblock_byte_ranges(const std::vector<llvm::Value *> & byteBlocks, const std::vector<std::vector<std::pair<unsigned, unsigned>>> & classes);
+
     ~IDISA_AVX2_Builder() {}
+
+protected:
+
+    using RangeTests = std::map<std::pair<unsigned, unsigned>, llvm::Value *>;
+
+    llvm::Value * byteMatchSignmask(llvm::Value * match);
+    llvm::Value * byteRangesMatch(llvm::Value * a, const std::vector<std::pair<unsigned, unsigned>> & ranges, RangeTests * tests = nullptr);
+    std::pair<llvm::Value *, llvm::Value *> byteNibbleLookupBase(llvm::Value * a);
+    llvm::Value * byteNibbleLookupMatch(const std::pair<llvm::Value *, llvm::Value *> & nibbleBase, const std::vector<std::pair<unsigned, unsigned>> & ranges);
+    bool useNibbleLookup(const std::vector<std::pair<unsigned, unsigned>> & ranges) const;
 };
 
 class IDISA_AVX512F_Builder : public IDISA_AVX2_Builder {
@@ -86,22 +114,20 @@ private:
     };
 
     void getHostCPUFeatures() {
-        llvm::StringMap<bool> features;
-        if (llvm::sys::getHostCPUFeatures(features)) {
-            hostCPUFeatures.hasAVX512CD = features.lookup("avx512cd");
-            hostCPUFeatures.hasAVX512BW = features.lookup("avx512bw");
-            hostCPUFeatures.hasAVX512DQ = features.lookup("avx512dq");
-            hostCPUFeatures.hasAVX512VL = features.lookup("avx512vl");
-
-
-            //hostCPUFeatures.hasAVX512VBMI, hostCPUFeatures.hasAVX512VBMI2,
-            //hostCPUFeatures.hasAVX512VPOPCNTDQ have not been tested as we
-            //did not have hardware support. It should work in theory (tm)
-
-            hostCPUFeatures.hasAVX512VBMI = features.lookup("avx512_vbmi");
-            hostCPUFeatures.hasAVX512VBMI2 = features.lookup("avx512_vbmi2");
-            hostCPUFeatures.hasAVX512VPOPCNTDQ = features.lookup("avx512_vpopcntdq");
-        }
+        const llvm::StringMap<bool> & features = getHostCPUFeatureMap();
+        hostCPUFeatures.hasAVX512CD = features.lookup("avx512cd");
+        hostCPUFeatures.hasAVX512BW = features.lookup("avx512bw");
+        hostCPUFeatures.hasAVX512DQ = features.lookup("avx512dq");
+        hostCPUFeatures.hasAVX512VL = features.lookup("avx512vl");
+
+
+        //hostCPUFeatures.hasAVX512VBMI, hostCPUFeatures.hasAVX512VBMI2,
+        //hostCPUFeatures.hasAVX512VPOPCNTDQ have not been tested as we
+        //did not have hardware support. It should work in theory (tm)
+
+        hostCPUFeatures.hasAVX512VBMI = features.lookup("avx512_vbmi");
+        hostCPUFeatures.hasAVX512VBMI2 = features.lookup("avx512_vbmi2");
+        hostCPUFeatures.hasAVX512VPOPCNTDQ = features.lookup("avx512_vpopcntdq");
     }
 
     Features hostCPUFeatures;
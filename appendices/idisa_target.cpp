@@ -25,31 +25,33 @@ struct Features {
     Features() : hasAVX(0), hasAVX2(0), hasAVX512F(0) { }
 };
 
+const StringMap<bool> & IDISA::getHostCPUFeatureMap() {
+    // Host features cannot change within a run; query them once and share the result.
+    static const StringMap<bool> hostFeatures = [] {
+        StringMap<bool> features;
+        if (!sys::getHostCPUFeatures(features)) {
+            features.clear();
+        }
+        return features;
+    }();
+    return hostFeatures;
+}
+
 Features getHostCPUFeatures() {
     Features hostCPUFeatures;
-    StringMap<bool> features;
-    if (sys::getHostCPUFeatures(features)) {
-        hostCPUFeatures.hasAVX = features.lookup("avx");
-        hostCPUFeatures.hasAVX2 = features.lookup("avx2");
-        hostCPUFeatures.hasAVX512F = features.lookup("avx512f");
-    }
+    const auto & features = IDISA::getHostCPUFeatureMap();
+    hostCPUFeatures.hasAVX = features.lookup("avx");
+    hostCPUFeatures.hasAVX2 = features.lookup("avx2");
+    hostCPUFeatures.hasAVX512F = features.lookup("avx512f");
     return hostCPUFeatures;
 }
 
 bool AVX2_available() {
-    StringMap<bool> features;
-    if (sys::getHostCPUFeatures(features)) {
-        return features.lookup("avx2");
-    }
-    return false;
+    return IDISA::getHostCPUFeatureMap().lookup("avx2");
 }
 
 bool AVX512BW_available() {
-    StringMap<bool> features;
-    if (sys::getHostCPUFeatures(features)) {
-        return features.lookup("avx512bw");
-    }
-    return false;
+    return IDISA::getHostCPUFeatureMap().lookup("avx512bw");
 }
 
 namespace IDISA {